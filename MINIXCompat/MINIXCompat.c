@@ -20,13 +20,19 @@
 #include <unistd.h>
 
 #include "MINIXCompat_Types.h"
+#include "MINIXCompat_Dependencies.h"
 #include "MINIXCompat_Emulation.h"
 #include "MINIXCompat_Executable.h"
 #include "MINIXCompat_Filesystem.h"
 #include "MINIXCompat_Logging.h"
 #include "MINIXCompat_Messages.h"
+#include "MINIXCompat_PIDRegistry.h"
+#include "MINIXCompat_Probes.h"
 #include "MINIXCompat_Processes.h"
+#include "MINIXCompat_Scheduling.h"
 #include "MINIXCompat_SysCalls.h"
+#include "MINIXCompat_WorkingSet.h"
+#include "MINIXCompat_WriteRing.h"
 
 
 static MINIXCompat_Execution_State MINIXCompat_State = MINIXCompat_Execution_State_Started;
@@ -45,9 +51,14 @@ int main(int argc, char **argv, char **envp)
 
     MINIXCompat_Log_Initialize();
     MINIXCompat_Filesystem_Initialize();
+    MINIXCompat_Dependencies_Initialize();
     MINIXCompat_CPU_Initialize();
+    MINIXCompat_WorkingSet_Initialize();
+    MINIXCompat_PIDRegistry_Initialize();
     MINIXCompat_Processes_Initialize();
     MINIXCompat_SysCall_Initialize();
+    MINIXCompat_WriteRing_Initialize();
+    MINIXCompat_Scheduling_Initialize();
 
     // Run the main emulation loop.
 
@@ -67,19 +78,26 @@ int main(int argc, char **argv, char **envp)
                 // Reset the emulated CPU so it's prepared to run, then swtich to the running state.
 
                 MINIXCompat_CPU_Reset();
+                MINIXCompat_WriteRing_Reset();
                 MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Running);
             } break;
 
             case MINIXCompat_Execution_State_Running: {
-                // Run the emulated CPU for a bunch of cycles.
+                // Run the emulated CPU for a bunch of cycles, as many as the scheduling class calls for.
 
-                (void) MINIXCompat_CPU_Run(10000);
+                int slice_cycles = MINIXCompat_Scheduling_SliceCycles();
+                MINIXCOMPAT_PROBE1(slice__start, slice_cycles);
+                int cycles_run = MINIXCompat_CPU_Run(slice_cycles);
+                MINIXCOMPAT_PROBE1(slice__end, cycles_run);
 
-                // If the execution state hasn't changed as a result of running the emulated CPU, handle any pending signals.
+                // If the execution state hasn't changed as a result of running the emulated CPU, perform any writes it queued and handle any pending signals.
 
                 if (MINIXCompat_State == MINIXCompat_Execution_State_Running) {
+                    MINIXCompat_WriteRing_Drain();
                     MINIXCompat_Processes_HandlePendingSignals();
                 }
+
+                MINIXCompat_Scheduling_EndSlice();
             } break;
 
             case MINIXCompat_Execution_State_Finished: {
@@ -88,6 +106,11 @@ int main(int argc, char **argv, char **envp)
         }
     }
 
+    // Record what was used and produced, and which memory was touched, if requested.
+
+    MINIXCompat_Dependencies_Finish();
+    MINIXCompat_WorkingSet_Finish();
+
     // Exit with whatever our exit code should be.
 
 	return MINIXCompat_Processes_ExitStatus;
@@ -0,0 +1,350 @@
+//
+//  MINIXCompat_Dependencies.c
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#include "MINIXCompat_Dependencies.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_HostFile.h"
+#include "MINIXCompat_Logging.h"
+
+
+#if DEBUG
+
+/*! Uncomment to log every input and output noted. */
+//#define DEBUG_DEPENDENCIES 1
+
+#endif
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The host path of the dependency file to write, or `NULL` if dependency tracking is disabled. */
+static const char *MINIXCOMPAT_DEPFILE = NULL;
+
+/*! The unlinked log of inputs and outputs shared by all emulator processes, or `-1`. */
+static int MINIXCompat_Dependencies_LogFD = -1;
+
+/*! The host process ID of the top-level emulator, which is the one that writes the dependency file. */
+static pid_t MINIXCompat_Dependencies_TopLevelPID = 0;
+
+
+/*! A list of unique host paths. */
+typedef struct minix_pathlist {
+    char **paths;
+    size_t count;
+    size_t capacity;
+} minix_pathlist_t;
+
+
+void MINIXCompat_Dependencies_Initialize(void)
+{
+    MINIXCOMPAT_DEPFILE = getenv("MINIXCOMPAT_DEPFILE");
+    if (MINIXCOMPAT_DEPFILE == NULL) return;
+
+    // Create the log next to the dependency file, and unlink it right away so it can't be left behind; only the descriptor (which fork(2) shares) is needed.
+
+    size_t log_path_len = strlen(MINIXCOMPAT_DEPFILE) + sizeof(".log.XXXXXX");
+    char *log_path = calloc(log_path_len, sizeof(char));
+    snprintf(log_path, log_path_len, "%s.log.XXXXXX", MINIXCOMPAT_DEPFILE);
+
+    int log_fd = mkstemp(log_path);
+    if (log_fd == -1) {
+        fprintf(stderr, "Couldn't create dependency log for %s: %s\n", MINIXCOMPAT_DEPFILE, strerror(errno));
+        MINIXCOMPAT_DEPFILE = NULL;
+    } else {
+        (void) unlink(log_path);
+
+        // Appending makes each note a single atomic write, even with many processes sharing the log.
+
+        (void) fcntl(log_fd, F_SETFL, fcntl(log_fd, F_GETFL) | O_APPEND);
+
+        MINIXCompat_Dependencies_LogFD = log_fd;
+        MINIXCompat_Dependencies_TopLevelPID = getpid();
+    }
+
+    free(log_path);
+}
+
+
+/*! Append a note of the given kind for \a host_path to the log. */
+static void MINIXCompat_Dependencies_Note(char kind, const char *host_path)
+{
+    if (MINIXCompat_Dependencies_LogFD == -1) return;
+
+    // Resolve the path now, since it may be relative to a working directory that changes later.
+
+    char resolved_path[PATH_MAX];
+    const char *path = (realpath(host_path, resolved_path) != NULL) ? resolved_path : host_path;
+
+    // Build the whole note first so it's written all at once.
+
+    char note[PATH_MAX + 4];
+    int note_len = snprintf(note, sizeof(note), "%c %s\n", kind, path);
+    if ((note_len < 0) || ((size_t)note_len >= sizeof(note))) return;
+
+    ssize_t written = write(MINIXCompat_Dependencies_LogFD, note, note_len);
+    (void) written;
+
+#if DEBUG_DEPENDENCIES
+    MINIXCompat_Log("dependency %c %s", kind, path);
+#endif
+}
+
+void MINIXCompat_Dependencies_NoteInput(const char *host_path)
+{
+    MINIXCompat_Dependencies_Note('R', host_path);
+}
+
+void MINIXCompat_Dependencies_NoteOutput(const char *host_path)
+{
+    MINIXCompat_Dependencies_Note('W', host_path);
+}
+
+
+// MARK: - Writing
+
+static void MINIXCompat_PathList_Add(minix_pathlist_t * _Nonnull list, char *path)
+{
+    if (list->count == list->capacity) {
+        list->capacity = (list->capacity > 0) ? (list->capacity * 2) : 64;
+        list->paths = realloc(list->paths, list->capacity * sizeof(char *));
+        assert(list->paths != NULL);
+    }
+
+    list->paths[list->count++] = path;
+}
+
+static int MINIXCompat_PathList_Compare(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/*! Sort a list and remove duplicates. */
+static void MINIXCompat_PathList_Unique(minix_pathlist_t * _Nonnull list)
+{
+    if (list->count == 0) return;
+
+    qsort(list->paths, list->count, sizeof(char *), MINIXCompat_PathList_Compare);
+
+    size_t unique_count = 1;
+    for (size_t i = 1; i < list->count; i++) {
+        if (strcmp(list->paths[i], list->paths[unique_count - 1]) != 0) {
+            list->paths[unique_count++] = list->paths[i];
+        }
+    }
+    list->count = unique_count;
+}
+
+/*! Whether a sorted list contains \a path. */
+static bool MINIXCompat_PathList_Contains(const minix_pathlist_t * _Nonnull list, const char *path)
+{
+    if (list->count == 0) return false;
+    return (bsearch(&path, list->paths, list->count, sizeof(char *), MINIXCompat_PathList_Compare) != NULL);
+}
+
+/*! Whether \a path names a regular file. */
+static bool MINIXCompat_Dependencies_IsRegularFile(const char *path)
+{
+    struct stat sbuf;
+    return (stat(path, &sbuf) == 0) && S_ISREG(sbuf.st_mode);
+}
+
+/*! Write \a path to a make dependency file, escaping the characters that are special to make. */
+static void MINIXCompat_Dependencies_WriteEscaped(FILE *depfile, const char *path)
+{
+    for (const char *p = path; *p != '\0'; p++) {
+        switch (*p) {
+            case ' ':
+            case '#':
+            case '\\':
+                fputc('\\', depfile);
+                fputc(*p, depfile);
+                break;
+
+            case '$':
+                fputs("$$", depfile);
+                break;
+
+            default:
+                fputc(*p, depfile);
+                break;
+        }
+    }
+}
+
+/*! Read the whole log into a NUL-terminated buffer. */
+static char *MINIXCompat_Dependencies_CopyLog(void)
+{
+    size_t log_len = 0;
+    size_t log_capacity = 4096;
+    char *log = malloc(log_capacity);
+    assert(log != NULL);
+
+    for (;;) {
+        if ((log_capacity - log_len) < 4096) {
+            log_capacity *= 2;
+            log = realloc(log, log_capacity);
+            assert(log != NULL);
+        }
+
+        ssize_t bytesread = pread(MINIXCompat_Dependencies_LogFD, log + log_len, log_capacity - log_len - 1, log_len);
+        if (bytesread < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (bytesread == 0) break;
+        log_len += bytesread;
+    }
+
+    log[log_len] = '\0';
+    return log;
+}
+
+/*! The inputs and outputs to write, and where the dependency file is going. */
+typedef struct minix_dependencies {
+    const char *depfile_path;
+    const minix_pathlist_t *inputs;
+    const minix_pathlist_t *outputs;
+} minix_dependencies_t;
+
+/*! Write a make dependency file: targets, then prerequisites, one per continuation line. */
+static bool MINIXCompat_Dependencies_WriteDepfile(FILE * _Nonnull file, const void * _Nullable context)
+{
+    const minix_dependencies_t *dependencies = context;
+
+    const char *target = getenv("MINIXCOMPAT_DEPFILE_TARGET");
+    if (target != NULL) {
+        MINIXCompat_Dependencies_WriteEscaped(file, target);
+    } else if (dependencies->outputs->count > 0) {
+        for (size_t i = 0; i < dependencies->outputs->count; i++) {
+            if (i > 0) fputc(' ', file);
+            MINIXCompat_Dependencies_WriteEscaped(file, dependencies->outputs->paths[i]);
+        }
+    } else {
+        MINIXCompat_Dependencies_WriteEscaped(file, dependencies->depfile_path);
+    }
+    fputc(':', file);
+
+    for (size_t i = 0; i < dependencies->inputs->count; i++) {
+        fputs(" \\\n  ", file);
+        MINIXCompat_Dependencies_WriteEscaped(file, dependencies->inputs->paths[i]);
+    }
+    fputc('\n', file);
+
+    return true;
+}
+
+/*! Write the list of outputs, one per line. */
+static bool MINIXCompat_Dependencies_WriteOutputs(FILE * _Nonnull file, const void * _Nullable context)
+{
+    const minix_dependencies_t *dependencies = context;
+
+    for (size_t i = 0; i < dependencies->outputs->count; i++) {
+        fprintf(file, "%s\n", dependencies->outputs->paths[i]);
+    }
+
+    return true;
+}
+
+/*! Write \a path with \a writer, warning if that fails. */
+static bool MINIXCompat_Dependencies_WriteFile(const char *path, MINIXCompat_HostFile_Writer writer, const minix_dependencies_t * _Nonnull dependencies)
+{
+    bool ok = MINIXCompat_HostFile_WriteAtomically(path, writer, dependencies);
+    if (!ok) {
+        fprintf(stderr, "Couldn't write %s: %s\n", path, strerror(errno));
+    }
+    return ok;
+}
+
+void MINIXCompat_Dependencies_Finish(void)
+{
+    if (MINIXCompat_Dependencies_LogFD == -1) return;
+    if (getpid() != MINIXCompat_Dependencies_TopLevelPID) return;
+
+    // Split the log into everything read and everything written.
+
+    char *log = MINIXCompat_Dependencies_CopyLog();
+
+    minix_pathlist_t read_paths = {0};
+    minix_pathlist_t written_paths = {0};
+
+    char *line = log;
+    while (*line != '\0') {
+        char *newline = strchr(line, '\n');
+        if (newline == NULL) break; // a partial note from a process that was killed while writing it
+        *newline = '\0';
+
+        if ((line[0] == 'R') && (line[1] == ' ')) {
+            MINIXCompat_PathList_Add(&read_paths, line + 2);
+        } else if ((line[0] == 'W') && (line[1] == ' ')) {
+            MINIXCompat_PathList_Add(&written_paths, line + 2);
+        }
+
+        line = newline + 1;
+    }
+
+    // Outputs are whatever was written that still exists; inputs are whatever was read that still exists and isn't an output.
+
+    MINIXCompat_PathList_Unique(&written_paths);
+    minix_pathlist_t outputs = {0};
+    for (size_t i = 0; i < written_paths.count; i++) {
+        if (MINIXCompat_Dependencies_IsRegularFile(written_paths.paths[i])) {
+            MINIXCompat_PathList_Add(&outputs, written_paths.paths[i]);
+        }
+    }
+
+    MINIXCompat_PathList_Unique(&read_paths);
+    minix_pathlist_t inputs = {0};
+    for (size_t i = 0; i < read_paths.count; i++) {
+        if (   !MINIXCompat_PathList_Contains(&outputs, read_paths.paths[i])
+            && MINIXCompat_Dependencies_IsRegularFile(read_paths.paths[i])) {
+            MINIXCompat_PathList_Add(&inputs, read_paths.paths[i]);
+        }
+    }
+
+    // Write the output list first, so a complete dependency file always has a matching output list.
+
+    size_t outputs_path_len = strlen(MINIXCOMPAT_DEPFILE) + sizeof(".outputs");
+    char *outputs_path = calloc(outputs_path_len, sizeof(char));
+    snprintf(outputs_path, outputs_path_len, "%s.outputs", MINIXCOMPAT_DEPFILE);
+
+    const minix_dependencies_t dependencies = {
+        .depfile_path = MINIXCOMPAT_DEPFILE,
+        .inputs = &inputs,
+        .outputs = &outputs,
+    };
+
+    if (MINIXCompat_Dependencies_WriteFile(outputs_path, MINIXCompat_Dependencies_WriteOutputs, &dependencies)) {
+        (void) MINIXCompat_Dependencies_WriteFile(MINIXCOMPAT_DEPFILE, MINIXCompat_Dependencies_WriteDepfile, &dependencies);
+    }
+
+    free(outputs_path);
+    free(inputs.paths);
+    free(outputs.paths);
+    free(read_paths.paths);
+    free(written_paths.paths);
+    free(log);
+
+    (void) close(MINIXCompat_Dependencies_LogFD);
+    MINIXCompat_Dependencies_LogFD = -1;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,44 @@
+//
+//  MINIXCompat_Dependencies.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Dependencies_h
+#define MINIXCompat_Dependencies_h
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Dependency tracking for host build systems.
+
+ When `MINIXCOMPAT_DEPFILE` names a host file, every file that the MINIX command or any of its descendants reads, executes, or successfully `stat(2)`s is noted as an input, and every file it writes, creates, or renames into place is noted as an output. When the top-level emulator process exits, it writes a make-compatible dependency file there, of the form `outputs: inputs`, along with a list of outputs (one per line) next to it with `.outputs` appended.
+
+ Only regular files that still exist at exit are listed, so temporary files don't appear, and inputs that are also outputs are only listed as outputs. If `MINIXCOMPAT_DEPFILE_TARGET` is set, it's used as the target instead of the outputs; if there are no outputs either, the dependency file itself is the target.
+
+ Notes from all processes are appended to one unlinked log file that's shared across `fork(2)`, so the results are only complete if descendants have exited by the time the top-level process does.
+ */
+
+
+/*! Initialize the dependency tracking subsystem, enabling it if requested by the host environment. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Dependencies_Initialize(void);
+
+/*! Note that the file at the given host path was used as an input. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Dependencies_NoteInput(const char *host_path);
+
+/*! Note that the file at the given host path was produced as an output. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Dependencies_NoteOutput(const char *host_path);
+
+/*! Write the dependency file and output list, if this is the top-level process and dependency tracking is enabled. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Dependencies_Finish(void);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Dependencies_h */
@@ -14,8 +14,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <arpa/inet.h> /* for ntohs et al */
+#include <sys/mman.h>
 
 #include "MINIXCompat_Types.h"
 #include "MINIXCompat_Executable.h"
@@ -40,10 +42,11 @@ static int MINIXCompat_CPU_Trap_Callback(int trap);
 
 int MINIXCompat_CPU_Initialize(void)
 {
-    // Configure the RAM.
+    // Configure the RAM. This is mapped directly rather than allocated so it's page-aligned, allowing the host to be told about how pages will be used (see ``MINIXCompat_RAM_Discard`` et al); it's still zero-filled on demand.
 
-    MINIXCompat_RAM = calloc(16 * 1024 * 1024, sizeof(uint8_t));
-    assert(MINIXCompat_RAM != NULL);
+    void *RAM = mmap(NULL, 16 * 1024 * 1024, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(RAM != MAP_FAILED);
+    MINIXCompat_RAM = RAM;
 
     // Configure the CPU.
 
@@ -235,6 +238,71 @@ void *MINIXCompat_RAM_Copy_Block_To_Host(m68k_address_t m68k_address, uint32_t m
 }
 
 
+void *MINIXCompat_RAM_Block_In_Host(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
+    assert(m68k_address < 0x01000000);
+    assert((m68k_block_size + m68k_address) <= 0x01000000);
+
+    return MINIXCompat_RAM + m68k_address;
+}
+
+uint32_t MINIXCompat_RAM_HostPageSize(void)
+{
+    return (uint32_t)sysconf(_SC_PAGESIZE);
+}
+
+bool MINIXCompat_RAM_Discard(void)
+{
+    // Mapping over the existing RAM in place keeps every pointer into it valid.
+
+    void *new_RAM = mmap(MINIXCompat_RAM, 16 * 1024 * 1024, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    return (new_RAM != MAP_FAILED);
+}
+
+void MINIXCompat_RAM_Populate(m68k_address_t m68k_address, uint32_t m68k_block_size)
+{
+    assert(m68k_address < 0x01000000);
+    assert((m68k_block_size + m68k_address) <= 0x01000000);
+
+    const uint32_t page_size = MINIXCompat_RAM_HostPageSize();
+    const uint32_t page_mask = page_size - 1;
+    uint32_t start = m68k_address & ~page_mask;
+    uint32_t end = (m68k_address + m68k_block_size + page_mask) & ~page_mask;
+    if (end > 0x01000000) end = 0x01000000;
+
+#if defined(MADV_POPULATE_WRITE)
+    if (madvise(MINIXCompat_RAM + start, end - start, MADV_POPULATE_WRITE) == 0) return;
+#endif
+
+    // Without a way to populate a range in one operation (or on a host kernel too old to support it), at least take all the faults now, in a tight loop.
+
+    for (uint32_t offset = start; offset < end; offset += page_size) {
+        volatile uint8_t *byte = MINIXCompat_RAM + offset;
+        *byte = *byte;
+    }
+}
+
+uint8_t *MINIXCompat_RAM_CopyResidency(void)
+{
+    const uint32_t page_size = MINIXCompat_RAM_HostPageSize();
+    const uint32_t page_count = ((16 * 1024 * 1024) + page_size - 1) / page_size;
+    uint8_t *residency = calloc(page_count, sizeof(uint8_t));
+
+    // The vector's type differs between hosts, so pass it untyped.
+
+    if (mincore(MINIXCompat_RAM, 16 * 1024 * 1024, (void *)residency) != 0) {
+        free(residency);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < page_count; i++) {
+        residency[i] &= 1;
+    }
+
+    return residency;
+}
+
+
 unsigned int m68k_read_memory_8(unsigned int address)
 {
     return MINIXCompat_RAM_Read_8(address);
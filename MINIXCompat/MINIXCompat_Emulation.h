@@ -9,6 +9,8 @@
 #ifndef MINIXCompat_Emulation_h
 #define MINIXCompat_Emulation_h
 
+#include <stdbool.h>
+
 #include "MINIXCompat_Types.h"
 
 
@@ -74,6 +76,37 @@ MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Copy_Block_From_Host(m68k_address_t m68k
  */
 MINIXCOMPAT_EXTERN void *MINIXCompat_RAM_Copy_Block_To_Host(m68k_address_t m68k_address, uint32_t m68k_block_size);
 
+/*!
+ Get a host pointer to a block of emulated memory, so host APIs can read or write it in place without an intermediate copy.
+
+ The `m68k_block_size` plus the `m68k_address` must not extend past the end of the 16MB address space. The block is in the emulated CPU's (big-endian) byte order.
+ */
+MINIXCOMPAT_EXTERN void *MINIXCompat_RAM_Block_In_Host(m68k_address_t m68k_address, uint32_t m68k_block_size);
+
+/*! The size of a host page of emulated memory, which is the granularity of ``MINIXCompat_RAM_Populate`` and ``MINIXCompat_RAM_CopyResidency``. */
+MINIXCOMPAT_EXTERN uint32_t MINIXCompat_RAM_HostPageSize(void);
+
+/*!
+ Replace all of emulated memory with fresh zero-filled pages that the host hasn't made resident yet.
+
+ - Returns: Whether that was possible; if not, emulated memory is unchanged.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_RAM_Discard(void);
+
+/*!
+ Make a block of emulated memory resident and writable now, rather than as it's first touched.
+
+ The block is widened to whole host pages. The `m68k_block_size` plus the `m68k_address` must not extend past the end of the 16MB address space.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_RAM_Populate(m68k_address_t m68k_address, uint32_t m68k_block_size);
+
+/*!
+ Find out which host pages of emulated memory are resident. The result is a new allocation created with `calloc` that must be freed using `free`, with one byte per host page that's nonzero if the page is resident.
+
+ - Returns: The residency of each page, or `NULL` if the host can't tell.
+ */
+MINIXCOMPAT_EXTERN uint8_t * _Nullable MINIXCompat_RAM_CopyResidency(void);
+
 
 MINIXCOMPAT_HEADER_END
 
@@ -19,6 +19,7 @@
 
 #include "MINIXCompat_Types.h"
 #include "MINIXCompat_Errors.h"
+#include "MINIXCompat_Probes.h"
 
 
 MINIXCOMPAT_SOURCE_BEGIN
@@ -132,6 +133,8 @@ int MINIXCompat_Executable_Load(FILE *pef, struct MINIXCompat_Executable * _Null
     // Set up the process' initial break
     minix_initial_break = exec_h->a_text + exec_h->a_data + exec_h->a_bss;
 
+    MINIXCOMPAT_PROBE3(load__image, exec_h->a_text, exec_h->a_data, exec_h->a_bss);
+
     return 0;
 }
 
@@ -23,9 +23,17 @@
 #include <sys/stat.h>
 
 #include "MINIXCompat_Types.h"
+#include "MINIXCompat_Dependencies.h"
 #include "MINIXCompat_Errors.h"
 #include "MINIXCompat_Logging.h"
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+
+/*! Whether to synthesize directory contents as they're read from the host via `getdents64(2)`, rather than caching them all at `open(2)` time. */
+#define MINIXCOMPAT_STREAM_DIRECTORIES 1
+#endif
+
 
 #if DEBUG
 
@@ -99,14 +107,20 @@ typedef struct minix_fdmap {
     /*! Whether the fd represents a file or a directory (or hasn't been checked). */
     enum { f_unchecked, f_file, f_directory } f_type;
 
-    /*! If this is a directory, the synthetic directory contents. */
+    /*! If this is a directory, the synthetic directory contents (unless they're streamed from the host). */
     minix_dirent_t *dir_entries;
 
-    /*! If this is a directory, the number of entries it contains, rounded up to the next multiple of 32; empty entries have a 0 inode. */
+    /*! If this is a directory, the number of entries it contains, rounded up to the next multiple of 32; empty entries have a 0 inode. When streaming, this is -1 until the end of the directory has been reached. */
     int16_t dir_count;
 
     /*! If this is a directory, the current directory read offset. */
     minix_off_t dir_offset;
+
+    /*! If this is a directory streamed from the host, the host position (as from `telldir(3)`) of the next host entry to read. */
+    off_t dir_host_pos;
+
+    /*! If this is a directory streamed from the host, the index of the next host entry to read. */
+    int32_t dir_host_index;
 } minix_fdmap_t;
 
 /*!
@@ -129,7 +143,13 @@ static void MINIXCompat_File_MINIXStatBufForHostStatBuf(minix_stat_t * _Nonnull
 static minix_ino_t MINIXCompat_File_MINIXInodeForHostInode(ino_t host_inode);
 static int MINIXCompat_File_HostWhenceForMINIXWhence(minix_whence_t minix_whence);
 
+#if MINIXCOMPAT_STREAM_DIRECTORIES
+static void MINIXCompat_Dir_BeginStreaming(minix_fd_t minix_fd);
+static int16_t MINIXCompat_Dir_StreamRead(minix_fd_t minix_fd, uint8_t *host_buf, int16_t host_buf_size);
+static int16_t MINIXCompat_Dir_StreamCount(minix_fd_t minix_fd);
+#else
 static int16_t MINIXCompat_Dir_Precache(const char * _Nullable host_path, minix_fd_t minix_fd);
+#endif
 static int16_t MINIXCompat_Dir_CheckIfDirAndCache(const char * _Nonnull host_path, minix_fd_t minix_fd);
 static int16_t MINIXCompat_Dir_Read(minix_fd_t minix_fd, void *host_buf, int16_t host_buf_size);
 static int16_t MINIXCompat_Dir_Seek(minix_fd_t minix_fd, minix_off_t minix_offset, minix_whence_t minix_whence);
@@ -313,6 +333,8 @@ static void MINIXCompat_fd_ClearDescriptorEntry(minix_fd_t minix_fd)
     entry->dir_entries = NULL;
     entry->dir_count = -1;
     entry->dir_offset = -1;
+    entry->dir_host_pos = 0;
+    entry->dir_host_index = 0;
 }
 
 static bool MINIXCompat_fd_IsDirectory(minix_fd_t minix_fd)
@@ -479,6 +501,12 @@ static minix_fd_t MINIXCompat_File_OpenOrCreate(const char *minix_path, int16_t
                 minix_fd = diropen_result;
                 (void) close(host_fd);
                 MINIXCompat_fd_ClearDescriptorEntry(minix_fd);
+            } else {
+                // Note the file for dependency tracking according to how it's being accessed.
+
+                int access_mode = host_flags & O_ACCMODE;
+                if (access_mode != O_WRONLY) MINIXCompat_Dependencies_NoteInput(host_path);
+                if (access_mode != O_RDONLY) MINIXCompat_Dependencies_NoteOutput(host_path);
             }
             result = minix_fd;
         } else {
@@ -493,6 +521,13 @@ static minix_fd_t MINIXCompat_File_OpenOrCreate(const char *minix_path, int16_t
     return result;
 }
 
+bool MINIXCompat_File_IsWritable(minix_fd_t minix_fd)
+{
+    // Directories are only ever opened for reading, so a directory descriptor is never writable.
+
+    return MINIXCompat_fd_IsInRange(minix_fd) && MINIXCompat_fd_IsOpen(minix_fd) && !MINIXCompat_fd_IsDirectory(minix_fd);
+}
+
 int16_t MINIXCompat_File_Close(minix_fd_t minix_fd)
 {
     int16_t result;
@@ -720,6 +755,9 @@ int16_t MINIXCompat_File_Stat(const char * _Nonnull minix_path, minix_stat_t * _
         // Swap for passing back to MINIX.
         MINIXCompat_File_StatSwap(minix_stat_buf);
         result = 0;
+
+        // Whatever was examined is an input, such as a make(1) prerequisite.
+        MINIXCompat_Dependencies_NoteInput(host_path);
     } else {
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     }
@@ -826,6 +864,9 @@ int16_t MINIXCompat_File_Rename(const char *minix_path, const char *minix_path2)
     int rename_err = rename(host_path, host_path2);
     if (rename_err == 0) {
         result = 0;
+
+        // Whatever was renamed into place is an output.
+        MINIXCompat_Dependencies_NoteOutput(host_path2);
     } else {
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
     }
@@ -917,6 +958,18 @@ int16_t MINIXCompat_File_Chmod(const char *minix_path, minix_mode_t minix_mode)
 
 // MARK: - Directories
 
+/*! The number of entries in a MINIX directory block; directories are always a whole number of blocks, and at least one. */
+static const int16_t MINIXCompat_Dir_BlockEntries = 32;
+
+/*! The number of entries a directory appears to have, given the number of entries it actually has. */
+static int16_t MINIXCompat_Dir_PaddedCount(int32_t host_count)
+{
+    int32_t blocks = (host_count + MINIXCompat_Dir_BlockEntries - 1) / MINIXCompat_Dir_BlockEntries;
+    return ((blocks > 0) ? blocks : 1) * MINIXCompat_Dir_BlockEntries;
+}
+
+#if !MINIXCOMPAT_STREAM_DIRECTORIES
+
 /*! Pre-cache a directory for reading. */
 static int16_t MINIXCompat_Dir_Precache(const char * _Nullable host_path, minix_fd_t minix_fd)
 {
@@ -981,6 +1034,187 @@ static int16_t MINIXCompat_Dir_Precache(const char * _Nullable host_path, minix_
     return 0;
 }
 
+#else
+
+/*! The layout of a host directory entry as returned by `getdents64(2)`. */
+struct minix_host_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/*! A buffer of host directory entries, which lives on the stack while a directory is being read. */
+typedef struct minix_dirstream {
+    /*! Raw `getdents64(2)` output. */
+    _Alignas(8) uint8_t buf[4096];
+
+    /*! The number of valid bytes in `buf`. */
+    size_t len;
+
+    /*! The offset in `buf` of the next host directory entry. */
+    size_t pos;
+} minix_dirstream_t;
+
+/*! Prepare a directory to be streamed from the host as it's read. */
+static void MINIXCompat_Dir_BeginStreaming(minix_fd_t minix_fd)
+{
+    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+
+    entry->dir_entries = NULL;
+    entry->dir_count = -1;
+    entry->dir_offset = 0;
+    entry->dir_host_pos = 0;
+    entry->dir_host_index = 0;
+}
+
+/*! Get the next host directory entry from \a stream, refilling it from \a host_fd as needed. Returns 1 if there was one, 0 at the end of the directory, or `-errno` (a host error) on failure. */
+static int MINIXCompat_Dir_NextHostEntry(int host_fd, minix_dirstream_t * _Nonnull stream, struct minix_host_dirent64 * _Nullable * _Nonnull out_host_dirent)
+{
+    if (stream->pos >= stream->len) {
+        long bytesread = syscall(SYS_getdents64, host_fd, stream->buf, sizeof(stream->buf));
+        if (bytesread < 0) return -errno;
+        if (bytesread == 0) return 0;
+
+        stream->len = bytesread;
+        stream->pos = 0;
+    }
+
+    struct minix_host_dirent64 *host_dirent = (struct minix_host_dirent64 *)(stream->buf + stream->pos);
+    stream->pos += host_dirent->d_reclen;
+    *out_host_dirent = host_dirent;
+
+    return 1;
+}
+
+/*! Convert a host directory entry into a MINIX directory entry, which may be anywhere in emulated RAM. */
+static void MINIXCompat_Dir_ConvertHostEntry(minix_dirent_t * _Nonnull minix_dirent, const struct minix_host_dirent64 * _Nonnull host_dirent)
+{
+    // MINIX just wants inode and 14-character name, NUL-padded but not necessarily NUL-terminated. This is what strncpy(3) does, but a bounded length and a pair of short fixed-size copies let the compiler use a few wide moves instead of a byte loop.
+
+    minix_dirent->d_ino = htons(MINIXCompat_File_MINIXInodeForHostInode((ino_t)host_dirent->d_ino));
+
+    const size_t name_len = strnlen(host_dirent->d_name, sizeof(minix_dirent->d_name));
+    memcpy(minix_dirent->d_name, host_dirent->d_name, name_len);
+    memset(minix_dirent->d_name + name_len, 0, sizeof(minix_dirent->d_name) - name_len);
+}
+
+/*! Read entries from a directory streamed from the host, converting them as they are copied into \a host_buf, which is normally emulated RAM. */
+static int16_t MINIXCompat_Dir_StreamRead(minix_fd_t minix_fd, uint8_t *host_buf, int16_t host_buf_size)
+{
+    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+    const int32_t entry_size = sizeof(minix_dirent_t);
+
+    minix_off_t cur_off = entry->dir_offset;
+    int32_t remaining = host_buf_size;
+    uint8_t *out = host_buf;
+
+    // Reading entries before the ones the host has already provided means starting over. Either way, always seek to where this descriptor left off, since a host descriptor's position is shared across fork(2).
+
+    if ((cur_off / entry_size) < entry->dir_host_index) {
+        entry->dir_host_pos = 0;
+        entry->dir_host_index = 0;
+    }
+
+    off_t seek_result = lseek(entry->host_fd, entry->dir_host_pos, SEEK_SET);
+    if (seek_result == -1) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    }
+
+    minix_dirstream_t stream;
+    stream.len = 0;
+    stream.pos = 0;
+    bool host_done = false;
+
+    while (remaining > 0) {
+        // Once the end of the directory is known, stop there.
+
+        if ((entry->dir_count >= 0) && (cur_off >= (entry->dir_count * entry_size))) break;
+
+        const int32_t index = cur_off / entry_size;
+        const int32_t skip = cur_off % entry_size;
+
+        // Find the host entry for this index, skipping any before it.
+
+        struct minix_host_dirent64 *host_dirent = NULL;
+        while (!host_done && (entry->dir_host_index <= index)) {
+            int next_result = MINIXCompat_Dir_NextHostEntry(entry->host_fd, &stream, &host_dirent);
+            if (next_result < 0) {
+                return -MINIXCompat_Errors_MINIXErrorForHostError(-next_result);
+            } else if (next_result == 0) {
+                host_done = true;
+                host_dirent = NULL;
+                entry->dir_count = MINIXCompat_Dir_PaddedCount(entry->dir_host_index);
+            } else {
+                entry->dir_host_pos = host_dirent->d_off;
+                entry->dir_host_index += 1;
+            }
+        }
+
+        // Build each entry locally and copy as much of it as is wanted, since the guest can ask for entries at any address (including an odd one) and for any part of one. The copy is a fixed 16 bytes, so it costs next to nothing.
+
+        minix_dirent_t converted;
+
+        if (host_dirent != NULL) {
+            MINIXCompat_Dir_ConvertHostEntry(&converted, host_dirent);
+        } else if (index < entry->dir_count) {
+            memset(&converted, 0, entry_size);
+        } else {
+            break;
+        }
+
+        const int32_t chunk = (remaining < (entry_size - skip)) ? remaining : (entry_size - skip);
+        memcpy(out, ((uint8_t *)&converted) + skip, chunk);
+
+        out += chunk;
+        remaining -= chunk;
+        cur_off += chunk;
+    }
+
+    entry->dir_offset = cur_off;
+
+    return host_buf_size - remaining;
+}
+
+/*! Count the entries in a directory streamed from the host, so its end is known. */
+static int16_t MINIXCompat_Dir_StreamCount(minix_fd_t minix_fd)
+{
+    minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
+
+    off_t seek_result = lseek(entry->host_fd, 0, SEEK_SET);
+    if (seek_result == -1) {
+        return -MINIXCompat_Errors_MINIXErrorForHostError(errno);
+    }
+
+    minix_dirstream_t stream;
+    stream.len = 0;
+    stream.pos = 0;
+    int32_t host_count = 0;
+
+    for (;;) {
+        struct minix_host_dirent64 *host_dirent = NULL;
+        int next_result = MINIXCompat_Dir_NextHostEntry(entry->host_fd, &stream, &host_dirent);
+        if (next_result < 0) {
+            return -MINIXCompat_Errors_MINIXErrorForHostError(-next_result);
+        } else if (next_result == 0) {
+            break;
+        } else {
+            host_count += 1;
+        }
+    }
+
+    // The host descriptor is now at the end, so the next read needs to start over.
+
+    entry->dir_count = MINIXCompat_Dir_PaddedCount(host_count);
+    entry->dir_host_pos = 0;
+    entry->dir_host_index = 0;
+
+    return 0;
+}
+
+#endif
+
 /*! A version of `stat(2)` that handles `EINTR` and returns `-errno` instead of just `-1` on error. */
 static int stat_without_EINTR(const char * _Nonnull path, struct stat * _Nonnull sbuf)
 {
@@ -1025,9 +1259,14 @@ static int16_t MINIXCompat_Dir_CheckIfDirAndCache(const char * _Nonnull host_pat
     // NOTE: Since we're in the middle of opening, don't use IsOpen, IsDirectory, etc.
 
     if ((result == 0) && is_directory) {
+#if MINIXCOMPAT_STREAM_DIRECTORIES
+        // If the fd is a directory, its entries are synthesized as they're read.
+        MINIXCompat_Dir_BeginStreaming(minix_fd);
+#else
         // If the fd is a directory, pre-cache its entries, failing the open if that fails.
         int16_t precache_result = MINIXCompat_Dir_Precache(host_path, minix_fd);
         result = precache_result;
+#endif
     }
 
     return result;
@@ -1036,22 +1275,30 @@ static int16_t MINIXCompat_Dir_CheckIfDirAndCache(const char * _Nonnull host_pat
 /*! Read and return many entries from the directory into \a host_buf as are appropriate for \a host_buf_size. */
 static int16_t MINIXCompat_Dir_Read(minix_fd_t minix_fd, void *host_buf, int16_t host_buf_size)
 {
+#if MINIXCOMPAT_STREAM_DIRECTORIES
+    return MINIXCompat_Dir_StreamRead(minix_fd, host_buf, host_buf_size);
+#else
     int16_t result;
     minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
 
     const minix_off_t max_off_plus_one = entry->dir_count * sizeof(minix_dirent_t);
     const minix_off_t cur_off = entry->dir_offset;
 
-    if ((cur_off + host_buf_size) <= max_off_plus_one) {
+    // Like any other file, reading at the end yields nothing and reading across the end is short.
+
+    if (cur_off < max_off_plus_one) {
+        const minix_off_t available = max_off_plus_one - cur_off;
+        const int16_t len = (host_buf_size < available) ? host_buf_size : available;
         uint8_t *raw_dir_entries = (uint8_t *)entry->dir_entries;
-        memcpy(host_buf, raw_dir_entries + cur_off, host_buf_size);
-        entry->dir_offset += host_buf_size;
-        result = host_buf_size;
+        memcpy(host_buf, raw_dir_entries + cur_off, len);
+        entry->dir_offset += len;
+        result = len;
     } else {
-        result = MINIXCompat_Errors_MINIXErrorForHostError(EIO);
+        result = 0;
     }
 
     return result;
+#endif
 }
 
 /*! Seek within a directory. */
@@ -1065,8 +1312,28 @@ static int16_t MINIXCompat_Dir_Seek(minix_fd_t minix_fd, minix_off_t minix_offse
 
     minix_fdmap_t *entry = &MINIXCompat_fd_table[minix_fd];
 
+#if MINIXCOMPAT_STREAM_DIRECTORIES
+    // The end of a streamed directory isn't known until it's been read through, so count its entries if the seek depends on that. Every directory has at least one block of entries, so seeks within that don't.
+
+    const minix_off_t first_block_max_off = MINIXCompat_Dir_BlockEntries * sizeof(minix_dirent_t) - 1;
+    const minix_off_t unchecked_off = (minix_whence == minix_SEEK_SET) ? minix_offset
+                                    : (minix_whence == minix_SEEK_CUR) ? (entry->dir_offset + minix_offset)
+                                    : -1;
+
+    if ((entry->dir_count < 0) && ((unchecked_off < 0) || (unchecked_off > first_block_max_off))) {
+        int16_t count_result = MINIXCompat_Dir_StreamCount(minix_fd);
+        if (count_result < 0) {
+            return count_result;
+        }
+    }
+
+    const int16_t dir_count = (entry->dir_count >= 0) ? entry->dir_count : MINIXCompat_Dir_BlockEntries;
+#else
+    const int16_t dir_count = entry->dir_count;
+#endif
+
     const minix_off_t min_off = 0;
-    const minix_off_t max_off = entry->dir_count * sizeof(minix_dirent_t) - 1;
+    const minix_off_t max_off = dir_count * sizeof(minix_dirent_t) - 1;
     minix_off_t new_off;
 
     switch (minix_whence) {
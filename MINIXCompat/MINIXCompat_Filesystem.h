@@ -9,6 +9,8 @@
 #ifndef MINIXCompat_Filesystem_h
 #define MINIXCompat_Filesystem_h
 
+#include <stdbool.h>
+
 #include "MINIXCompat_Types.h"
 
 
@@ -128,6 +130,9 @@ MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Create(const char *minix_path, mi
  */
 MINIXCOMPAT_EXTERN minix_fd_t MINIXCompat_File_Open(const char *minix_path, int16_t minix_flags, minix_mode_t minix_mode);
 
+/*! Whether the given MINIX file descriptor is in range, open, and can be passed to ``MINIXCompat_File_Write``. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_File_IsWritable(minix_fd_t fd);
+
 /*! Close the file with the given MINIX file descriptor. */
 MINIXCOMPAT_EXTERN int16_t MINIXCompat_File_Close(minix_fd_t fd);
 
@@ -0,0 +1,56 @@
+//
+//  MINIXCompat_HostFile.c
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#include "MINIXCompat_HostFile.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+bool MINIXCompat_HostFile_WriteAtomically(const char *path, MINIXCompat_HostFile_Writer writer, const void *context)
+{
+    assert(path != NULL);
+    assert(writer != NULL);
+
+    // Name the temporary file after this process, so concurrent writers of the same file don't collide.
+
+    size_t temp_path_len = strlen(path) + 32;
+    char *temp_path = calloc(temp_path_len, sizeof(char));
+    snprintf(temp_path, temp_path_len, "%s.%d.tmp", path, (int)getpid());
+
+    bool ok = false;
+    FILE *file = fopen(temp_path, "w");
+    if (file != NULL) {
+        ok = writer(file, context) && (ferror(file) == 0);
+        ok = (fclose(file) == 0) && ok;
+        ok = ok && (rename(temp_path, path) == 0);
+    }
+
+    // Don't let cleanup obscure why writing failed.
+
+    int saved_errno = errno;
+    if (!ok) {
+        (void) unlink(temp_path);
+    }
+    free(temp_path);
+    errno = saved_errno;
+
+    return ok;
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,41 @@
+//
+//  MINIXCompat_HostFile.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_HostFile_h
+#define MINIXCompat_HostFile_h
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Helpers for files that MINIXCompat itself keeps on the host, as opposed to files the emulated MINIX system accesses.
+ */
+
+
+/*! Writes the contents of a host file to \a file, returning whether that succeeded. */
+typedef bool (*MINIXCompat_HostFile_Writer)(FILE * _Nonnull file, const void * _Nullable context);
+
+/*!
+ Replace the host file at \a path with the contents produced by \a writer.
+
+ The contents are written to a temporary file next to \a path that's then renamed into place, so other processes reading \a path (such as concurrent emulators) never see a partial file.
+
+ - Returns: Whether the file was written. If it wasn't, \a path is untouched and `errno` describes why.
+ */
+MINIXCOMPAT_EXTERN bool MINIXCompat_HostFile_WriteAtomically(const char * _Nonnull path, MINIXCompat_HostFile_Writer _Nonnull writer, const void * _Nullable context);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_HostFile_h */
@@ -0,0 +1,193 @@
+//
+//  MINIXCompat_PIDRegistry.c
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#include "MINIXCompat_PIDRegistry.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Errors.h"
+#include "MINIXCompat_Logging.h"
+
+
+#if DEBUG
+
+/*! Uncomment to log process ID allocation. */
+//#define DEBUG_PID_REGISTRY 1
+
+#endif
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The number of entries in the registry, one per 15-bit MINIX process ID. */
+#define MINIXCompat_PIDRegistry_Count 32768
+
+/*!
+ The lowest MINIX process ID the registry hands out.
+
+ Lower IDs are for MM, FS, init, and the pretend login session that a top-level process is run from (see ``MINIXCompat_Processes_Initialize``). Since those are never handed out, entry 0 of the registry instead holds where to start looking for a free entry.
+ */
+static const minix_pid_t MINIXCompat_PIDRegistry_First = 7;
+
+/*! The index of the entry holding where to start looking for a free entry. */
+static const size_t MINIXCompat_PIDRegistry_HintIndex = 0;
+
+
+/*! The host file backing the registry, or `-1` if the registry isn't in use. */
+static int MINIXCompat_PIDRegistry_FD = -1;
+
+/*! The registry itself, mapped from ``MINIXCompat_PIDRegistry_FD``; each entry is the host process ID holding that MINIX process ID, or 0. */
+static int32_t *MINIXCompat_PIDRegistry_Entries = NULL;
+
+
+void MINIXCompat_PIDRegistry_Initialize(void)
+{
+    const char *pid_file_path = getenv("MINIXCOMPAT_PID_FILE");
+    if (pid_file_path == NULL) return;
+
+    const size_t registry_size = MINIXCompat_PIDRegistry_Count * sizeof(int32_t);
+
+    int fd = open(pid_file_path, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        fprintf(stderr, "Couldn't open MINIX process ID registry %s: %s\n", pid_file_path, strerror(errno));
+        return;
+    }
+
+    // A new file is extended with zeroes, which means every entry is free. Extending an existing full-size file is harmless.
+
+    struct stat sbuf;
+    if ((fstat(fd, &sbuf) == -1) || ((sbuf.st_size < (off_t)registry_size) && (ftruncate(fd, registry_size) == -1))) {
+        fprintf(stderr, "Couldn't size MINIX process ID registry %s: %s\n", pid_file_path, strerror(errno));
+        (void) close(fd);
+        return;
+    }
+
+    void *entries = mmap(NULL, registry_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (entries == MAP_FAILED) {
+        fprintf(stderr, "Couldn't map MINIX process ID registry %s: %s\n", pid_file_path, strerror(errno));
+        (void) close(fd);
+        return;
+    }
+
+    MINIXCompat_PIDRegistry_FD = fd;
+    MINIXCompat_PIDRegistry_Entries = entries;
+}
+
+bool MINIXCompat_PIDRegistry_IsEnabled(void)
+{
+    return (MINIXCompat_PIDRegistry_Entries != NULL);
+}
+
+
+/*! Lock or unlock the whole registry against other processes. */
+static void MINIXCompat_PIDRegistry_Lock(bool lock)
+{
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = lock ? F_WRLCK : F_UNLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = 0;
+    fl.l_len = 0; // the whole file
+
+    int lock_err;
+    do {
+        lock_err = fcntl(MINIXCompat_PIDRegistry_FD, F_SETLKW, &fl);
+    } while ((lock_err == -1) && (errno == EINTR));
+}
+
+/*! Whether an entry's holder is gone, so the entry can be reused. Must be called with the registry locked. */
+static bool MINIXCompat_PIDRegistry_EntryIsFree(size_t index)
+{
+    const pid_t holder = MINIXCompat_PIDRegistry_Entries[index];
+    if (holder == 0) return true;
+
+    // A holder that's a zombie still exists, so its process ID isn't reused until it's been waited for, just like on a real system.
+
+    return (kill(holder, 0) == -1) && (errno == ESRCH);
+}
+
+minix_pid_t MINIXCompat_PIDRegistry_Allocate(pid_t holder)
+{
+    assert(MINIXCompat_PIDRegistry_IsEnabled());
+    assert(holder > 0);
+
+    minix_pid_t result = -MINIXCompat_Errors_MINIXErrorForHostError(EAGAIN);
+
+    MINIXCompat_PIDRegistry_Lock(true);
+
+    // Search round-robin from where the last allocation left off, like a real kernel, so process IDs aren't reused right away.
+
+    const size_t span = MINIXCompat_PIDRegistry_Count - MINIXCompat_PIDRegistry_First;
+    size_t hint = MINIXCompat_PIDRegistry_Entries[MINIXCompat_PIDRegistry_HintIndex];
+    if ((hint < (size_t)MINIXCompat_PIDRegistry_First) || (hint >= MINIXCompat_PIDRegistry_Count)) {
+        hint = MINIXCompat_PIDRegistry_First;
+    }
+
+    for (size_t i = 0; i < span; i++) {
+        const size_t index = MINIXCompat_PIDRegistry_First + (((hint - MINIXCompat_PIDRegistry_First) + i) % span);
+        if (MINIXCompat_PIDRegistry_EntryIsFree(index)) {
+            MINIXCompat_PIDRegistry_Entries[index] = holder;
+            MINIXCompat_PIDRegistry_Entries[MINIXCompat_PIDRegistry_HintIndex] = (int32_t)(index + 1);
+            result = (minix_pid_t)index;
+            break;
+        }
+    }
+
+    MINIXCompat_PIDRegistry_Lock(false);
+
+#if DEBUG_PID_REGISTRY
+    MINIXCompat_Log("allocated MINIX pid %d for host pid %d", result, holder);
+#endif
+
+    return result;
+}
+
+void MINIXCompat_PIDRegistry_Transfer(minix_pid_t minix_pid, pid_t old_holder, pid_t new_holder)
+{
+    assert(MINIXCompat_PIDRegistry_IsEnabled());
+    assert((minix_pid >= MINIXCompat_PIDRegistry_First) && (minix_pid < MINIXCompat_PIDRegistry_Count));
+
+    MINIXCompat_PIDRegistry_Lock(true);
+    if (MINIXCompat_PIDRegistry_Entries[minix_pid] == old_holder) {
+        MINIXCompat_PIDRegistry_Entries[minix_pid] = new_holder;
+    }
+    MINIXCompat_PIDRegistry_Lock(false);
+}
+
+void MINIXCompat_PIDRegistry_Release(minix_pid_t minix_pid, pid_t holder)
+{
+    assert(MINIXCompat_PIDRegistry_IsEnabled());
+
+    if ((minix_pid < MINIXCompat_PIDRegistry_First) || (minix_pid >= MINIXCompat_PIDRegistry_Count)) return;
+
+    MINIXCompat_PIDRegistry_Lock(true);
+    if (MINIXCompat_PIDRegistry_Entries[minix_pid] == holder) {
+        MINIXCompat_PIDRegistry_Entries[minix_pid] = 0;
+    }
+    MINIXCompat_PIDRegistry_Lock(false);
+
+#if DEBUG_PID_REGISTRY
+    MINIXCompat_Log("released MINIX pid %d from host pid %d", minix_pid, holder);
+#endif
+}
+
+
+MINIXCOMPAT_SOURCE_END
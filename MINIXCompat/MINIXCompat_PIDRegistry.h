@@ -0,0 +1,59 @@
+//
+//  MINIXCompat_PIDRegistry.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_PIDRegistry_h
+#define MINIXCompat_PIDRegistry_h
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Processes.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Host-wide allocation of MINIX process IDs.
+
+ Normally each MINIXCompat process tree numbers its processes from the same starting point, so concurrent trees sharing a `MINIXCOMPAT_DIR` see the same process IDs, and tools that derive temporary file names from `getpid(2)` collide. When `MINIXCOMPAT_PID_FILE` names a host file, every tree that names the same file allocates from a single shared table of the 15-bit MINIX process ID space instead.
+
+ Each entry in the table holds the host process ID of the emulator using that MINIX process ID, and entries whose holder no longer exists are reclaimed, so a crashed tree never leaks its process IDs for long. The table is a memory-mapped file updated under a POSIX record lock, which (unlike `flock(2)`) isn't shared with children across `fork(2)`.
+ */
+
+
+/*! Initialize the process ID registry, enabling it if requested by the host environment. */
+MINIXCOMPAT_EXTERN void MINIXCompat_PIDRegistry_Initialize(void);
+
+/*! Whether the host-wide process ID registry is in use. */
+MINIXCOMPAT_EXTERN bool MINIXCompat_PIDRegistry_IsEnabled(void);
+
+/*!
+ Allocate a MINIX process ID that no other live process in any tree is using.
+
+ - Parameters:
+   - holder: the host process that will use the MINIX process ID
+ - Returns: The allocated MINIX process ID, or `-errno` if there are none available.
+ */
+MINIXCOMPAT_EXTERN minix_pid_t MINIXCompat_PIDRegistry_Allocate(pid_t holder);
+
+/*! Change the host process holding a MINIX process ID, such as from a parent to the child it forked. */
+MINIXCOMPAT_EXTERN void MINIXCompat_PIDRegistry_Transfer(minix_pid_t minix_pid, pid_t old_holder, pid_t new_holder);
+
+/*!
+ Release a MINIX process ID, if it's still held by the given host process, such as when `fork(2)` fails.
+
+ Exiting processes don't release theirs: it's reclaimed once the holder has been waited for and no longer exists, so a parent can't lose track of a child whose process ID has been reused.
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_PIDRegistry_Release(minix_pid_t minix_pid, pid_t holder);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_PIDRegistry_h */
@@ -0,0 +1,54 @@
+//
+//  MINIXCompat_Probes.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Probes_h
+#define MINIXCompat_Probes_h
+
+#include "MINIXCompat_Types.h"
+
+
+/*
+ Static tracepoints for observing MINIXCompat from outside the process.
+
+ When the host provides `<sys/sdt.h>` (as Linux does via SystemTap's headers), each probe compiles to a single `nop` plus an ELF note describing its location and arguments, so tools like `bpftrace` and `perf` can attach to a running emulator without it being started in any special mode. On other hosts, or when `MINIXCOMPAT_DISABLE_PROBES` is defined, the probes compile away entirely.
+
+ All probes use the `minixcompat` provider:
+
+ - `syscall__entry(syscall, msg)` and `syscall__return(syscall, result)` bracket every system call sent to MM or FS; the tracer derives latency from the pair.
+ - `exec(path)` fires after a successful `exec(2)` has loaded its executable and stack.
+ - `fork(minix_pid, host_pid)` fires in the parent after a successful `fork(2)`.
+ - `exit(status)` fires when the MINIX process calls `_exit(2)`.
+ - `slice__start(cycles)` and `slice__end(cycles_run)` bracket each run of the emulated CPU in the main loop.
+ - `load__start(path)` and `load__done(path, result)` bracket loading an executable, and `load__image(text, data, bss)` reports the sizes of the image that was loaded.
+
+ Arguments must be integers or pointers.
+ */
+
+#if defined(__linux__) && defined(__has_include) && !defined(MINIXCOMPAT_DISABLE_PROBES)
+#if __has_include(<sys/sdt.h>)
+#define MINIXCOMPAT_HAVE_PROBES 1
+#endif
+#endif
+
+#if MINIXCOMPAT_HAVE_PROBES
+
+#include <sys/sdt.h>
+
+#define MINIXCOMPAT_PROBE1(name, a)          DTRACE_PROBE1(minixcompat, name, a)
+#define MINIXCOMPAT_PROBE2(name, a, b)       DTRACE_PROBE2(minixcompat, name, a, b)
+#define MINIXCOMPAT_PROBE3(name, a, b, c)    DTRACE_PROBE3(minixcompat, name, a, b, c)
+
+#else
+
+#define MINIXCOMPAT_PROBE1(name, a)          do { (void)(a); } while (0)
+#define MINIXCOMPAT_PROBE2(name, a, b)       do { (void)(a); (void)(b); } while (0)
+#define MINIXCOMPAT_PROBE3(name, a, b, c)    do { (void)(a); (void)(b); (void)(c); } while (0)
+
+#endif
+
+
+#endif /* MINIXCompat_Probes_h */
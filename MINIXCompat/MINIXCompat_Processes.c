@@ -25,10 +25,14 @@
 #include "MINIXCompat_Types.h"
 #include "MINIXCompat.h"
 #include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Dependencies.h"
 #include "MINIXCompat_Errors.h"
 #include "MINIXCompat_Executable.h"
 #include "MINIXCompat_Filesystem.h"
 #include "MINIXCompat_Logging.h"
+#include "MINIXCompat_PIDRegistry.h"
+#include "MINIXCompat_Probes.h"
+#include "MINIXCompat_WorkingSet.h"
 
 
 #if DEBUG
@@ -115,7 +119,16 @@ void MINIXCompat_Processes_Initialize(void)
      So the first process ID to use should be 7, with 6 as our parent, and the next PID should be 8.
      */
     const minix_pid_t pseudoparent = 6;
-    const minix_pid_t ourselves = 7;
+    minix_pid_t ourselves = 7;
+
+    // If process IDs are allocated host-wide, ours comes from there (or if that's full, the usual one).
+
+    if (MINIXCompat_PIDRegistry_IsEnabled()) {
+        minix_pid_t allocated_pid = MINIXCompat_PIDRegistry_Allocate(host_self_pid);
+        if (allocated_pid > 0) {
+            ourselves = allocated_pid;
+        }
+    }
 
     // An entry for ourselves, first for fastest access by linear search.
     MINIXCompat_ProcessTable[0].minix_pid = ourselves;
@@ -202,7 +215,16 @@ minix_pid_t MINIXCompat_Processes_fork(void)
     size_t new_process_entry = MINIXCompat_Processes_NextFreeTableEntry();
 
     // Get the child PID to use and bump the next MINIX pid to use, so both parent and child have a coherent view of the world.
-    minix_pid_t new_minix_process = minix_next_pid++;
+    // If process IDs are allocated host-wide, the parent holds the child's until it knows the child's host PID.
+    minix_pid_t new_minix_process;
+    if (MINIXCompat_PIDRegistry_IsEnabled()) {
+        new_minix_process = MINIXCompat_PIDRegistry_Allocate(getpid());
+        if (new_minix_process < 0) {
+            return new_minix_process;
+        }
+    } else {
+        new_minix_process = minix_next_pid++;
+    }
 
     // Actually fork the host.
     pid_t new_host_process = fork();
@@ -212,9 +234,13 @@ minix_pid_t MINIXCompat_Processes_fork(void)
 
         result = -MINIXCompat_Errors_MINIXErrorForHostError(errno);
 
-        // Reset minix_next_pid.
+        // Reset minix_next_pid, or give back the allocated pid.
 
-        minix_next_pid -= 1;
+        if (MINIXCompat_PIDRegistry_IsEnabled()) {
+            MINIXCompat_PIDRegistry_Release(new_minix_process, getpid());
+        } else {
+            minix_next_pid -= 1;
+        }
     } else if (new_host_process != 0) {
 #if DEBUG_FORK
         volatile int continue_parent = 0;
@@ -228,6 +254,12 @@ minix_pid_t MINIXCompat_Processes_fork(void)
         MINIXCompat_ProcessTable[new_process_entry].host_pid = new_host_process;
         MINIXCompat_ProcessTable[new_process_entry].minix_pid = new_minix_process;
 
+        if (MINIXCompat_PIDRegistry_IsEnabled()) {
+            MINIXCompat_PIDRegistry_Transfer(new_minix_process, getpid(), new_host_process);
+        }
+
+        MINIXCOMPAT_PROBE2(fork, new_minix_process, new_host_process);
+
         // Return the MINIX child PID.
 
         result = new_minix_process;
@@ -238,7 +270,7 @@ minix_pid_t MINIXCompat_Processes_fork(void)
             sleep(1);
         } while (!continue_child);
 #endif
-        // This is the child. Reinitialize logging (if it's a thing).
+        // This is the child. Reinitialize logging (if it's a thing). The host carries the scheduling class across, so that needs nothing.
 
         MINIXCompat_Log_Initialize();
 
@@ -254,6 +286,11 @@ minix_pid_t MINIXCompat_Processes_fork(void)
         MINIXCompat_ProcessTable[0].host_pid = getpid();
         MINIXCompat_ProcessTable[0].minix_pid = new_minix_process;
 
+        // Forget any IDs cached from the parent.
+
+        minix_self_pid = 0;
+        minix_self_ppid = 0;
+
         // Return 0 here, because if the new process needs its own ID it can always use getpid(2) to get that.
 
         result = 0;
@@ -323,6 +360,10 @@ int MINIXCompat_Processes_ExitStatus = 0;
 void MINIXCompat_Processes_exit(int16_t status)
 {
     MINIXCompat_Processes_ExitStatus = status;
+
+    // Our process ID stays registered until our parent has waited for us and the host process is gone, just like on a real system.
+
+    MINIXCOMPAT_PROBE1(exit, status);
     MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Finished);
 
 #if DEBUG_PROCESS_SYSCALLS
@@ -705,6 +746,8 @@ static int16_t MINIXCompat_Processes_LoadTool(const char *executable_path)
      I.e. if /tmp/foo.sh is an executable script that starts with `#!/bin/sh`, that means we'd load /bin/sh, pass /tmp/foo.sh as argv[1], and pass the other arguments as argv[2] and so on.
      */
 
+    MINIXCOMPAT_PROBE1(load__start, executable_path);
+
     // Get the path to the tool to run and ensure it actually exists.
 
     FILE *toolfile = NULL;
@@ -734,9 +777,12 @@ static int16_t MINIXCompat_Processes_LoadTool(const char *executable_path)
         goto done;
     }
 
+    MINIXCompat_WorkingSet_PrepareImage(executable_host_path, &executable_host_stat);
     MINIXCompat_RAM_Copy_Block_From_Host(MINIXCompat_Executable_Base, executable_text_and_data, executable_text_and_data_len);
     result = 0;
 
+    MINIXCompat_Dependencies_NoteInput(executable_host_path);
+
 done:
     if (toolfile) {
         fclose(toolfile);
@@ -744,6 +790,8 @@ done:
 
     free(executable_host_path);
 
+    MINIXCOMPAT_PROBE2(load__done, executable_path, result);
+
     return result;
 }
 
@@ -783,6 +831,8 @@ int16_t MINIXCompat_Processes_ExecuteWithStackBlock(const char *executable_path,
 
     MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Ready);
 
+    MINIXCOMPAT_PROBE1(exec, executable_path);
+
 #if DEBUG_PROCESS_SYSCALLS
     MINIXCompat_Log("exec(\"%s\")", executable_path);
 #endif
@@ -821,6 +871,8 @@ int16_t MINIXCompat_Processes_ExecuteWithHostParams(const char *executable_path,
 
     MINIXCompat_Execution_ChangeState(MINIXCompat_Execution_State_Ready);
 
+    MINIXCOMPAT_PROBE1(exec, executable_path);
+
 #if DEBUG_PROCESS_SYSCALLS
     MINIXCompat_Log("exec_host(\"%s\")", executable_path);
 #endif
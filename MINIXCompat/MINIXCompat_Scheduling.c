@@ -0,0 +1,167 @@
+//
+//  MINIXCompat_Scheduling.c
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+// glibc only declares SCHED_BATCH for GNU sources; this must come before any system header.
+#if __linux__
+#define _GNU_SOURCE 1
+#endif
+
+#include "MINIXCompat_Scheduling.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Logging.h"
+
+
+#if DEBUG
+
+/*! Uncomment to log the scheduling class in use. */
+//#define DEBUG_SCHEDULING 1
+
+#endif
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The scheduling classes that can be requested via `MINIXCOMPAT_CLASS`. */
+typedef enum MINIXCompat_Scheduling_Class : int {
+    MINIXCompat_Scheduling_Class_Default = 0,
+    MINIXCompat_Scheduling_Class_Interactive,
+    MINIXCompat_Scheduling_Class_Batch,
+} MINIXCompat_Scheduling_Class;
+
+
+/*! The cycles per time slice by default and for interactive emulators. */
+static const int MINIXCompat_Scheduling_InteractiveSliceCycles = 10000;
+
+/*! The cycles per time slice for batch emulators, which trade latency for fewer trips around the main loop. */
+static const int MINIXCompat_Scheduling_BatchSliceCycles = 100000;
+
+/*! The host priority adjustment for batch emulators. */
+static const int MINIXCompat_Scheduling_BatchNice = 10;
+
+
+/*! The scheduling class in use. */
+static MINIXCompat_Scheduling_Class MINIXCompat_Scheduling_CurrentClass = MINIXCompat_Scheduling_Class_Default;
+
+
+/*! Set the host scheduling policy, on hosts that distinguish batch work. */
+static void MINIXCompat_Scheduling_SetPolicy(MINIXCompat_Scheduling_Class class);
+
+/*! Move this process into the host cgroup at \a cgroup_path. */
+static void MINIXCompat_Scheduling_JoinCgroup(const char *cgroup_path);
+
+
+void MINIXCompat_Scheduling_Initialize(void)
+{
+    const char *class_name = getenv("MINIXCOMPAT_CLASS");
+    if (class_name != NULL) {
+        if (strcmp(class_name, "batch") == 0) {
+            MINIXCompat_Scheduling_CurrentClass = MINIXCompat_Scheduling_Class_Batch;
+        } else if (strcmp(class_name, "interactive") == 0) {
+            MINIXCompat_Scheduling_CurrentClass = MINIXCompat_Scheduling_Class_Interactive;
+        } else {
+            fprintf(stderr, "Unknown MINIXCOMPAT_CLASS \"%s\", ignoring.\n", class_name);
+        }
+    }
+
+    // Scheduling is best-effort: a host that refuses a change just leaves the emulator scheduled as it was.
+
+    errno = 0;
+    int nice_value = getpriority(PRIO_PROCESS, 0);
+    if (errno == 0) {
+        if (MINIXCompat_Scheduling_CurrentClass == MINIXCompat_Scheduling_Class_Batch) {
+            (void) setpriority(PRIO_PROCESS, 0, nice_value + MINIXCompat_Scheduling_BatchNice);
+        } else if ((MINIXCompat_Scheduling_CurrentClass == MINIXCompat_Scheduling_Class_Interactive) && (nice_value > 0)) {
+            // Undo a lowered priority inherited from whatever started the emulator, such as a batch build; hosts generally only allow this up to a resource limit.
+            (void) setpriority(PRIO_PROCESS, 0, 0);
+        }
+    }
+
+    if (MINIXCompat_Scheduling_CurrentClass != MINIXCompat_Scheduling_Class_Default) {
+        MINIXCompat_Scheduling_SetPolicy(MINIXCompat_Scheduling_CurrentClass);
+    }
+
+    const char *cgroup_path = getenv("MINIXCOMPAT_CGROUP");
+    if (cgroup_path != NULL) {
+        MINIXCompat_Scheduling_JoinCgroup(cgroup_path);
+    }
+
+#if DEBUG_SCHEDULING
+    MINIXCompat_Log("scheduling class %d, %d cycles per slice", MINIXCompat_Scheduling_CurrentClass, MINIXCompat_Scheduling_SliceCycles());
+#endif
+}
+
+
+static void MINIXCompat_Scheduling_SetPolicy(MINIXCompat_Scheduling_Class class)
+{
+#if defined(SCHED_BATCH)
+    struct sched_param param = { .sched_priority = 0 };
+    int policy = (class == MINIXCompat_Scheduling_Class_Batch) ? SCHED_BATCH : SCHED_OTHER;
+    (void) sched_setscheduler(0, policy, &param);
+#else
+    // There's no separate batch policy on this host, so priority alone distinguishes the classes.
+    (void) class;
+#endif
+}
+
+
+static void MINIXCompat_Scheduling_JoinCgroup(const char *cgroup_path)
+{
+    size_t procs_path_len = strlen(cgroup_path) + sizeof("/cgroup.procs");
+    char *procs_path = calloc(procs_path_len, sizeof(char));
+    snprintf(procs_path, procs_path_len, "%s/cgroup.procs", cgroup_path);
+
+    // The write itself is what the host refuses (such as without a delegated cgroup), which may only be reported when the file is closed.
+
+    bool joined = false;
+    FILE *procs_file = fopen(procs_path, "w");
+    if (procs_file != NULL) {
+        joined = (fprintf(procs_file, "%d\n", (int)getpid()) > 0);
+        joined = (fclose(procs_file) == 0) && joined;
+    }
+
+    if (!joined) {
+        fprintf(stderr, "Couldn't join cgroup %s: %s\n", cgroup_path, strerror(errno));
+    }
+
+    free(procs_path);
+}
+
+
+int MINIXCompat_Scheduling_SliceCycles(void)
+{
+    switch (MINIXCompat_Scheduling_CurrentClass) {
+        case MINIXCompat_Scheduling_Class_Batch:
+            return MINIXCompat_Scheduling_BatchSliceCycles;
+
+        case MINIXCompat_Scheduling_Class_Default:
+        case MINIXCompat_Scheduling_Class_Interactive:
+            return MINIXCompat_Scheduling_InteractiveSliceCycles;
+    }
+}
+
+
+void MINIXCompat_Scheduling_EndSlice(void)
+{
+    if (MINIXCompat_Scheduling_CurrentClass == MINIXCompat_Scheduling_Class_Batch) {
+        (void) sched_yield();
+    }
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,46 @@
+//
+//  MINIXCompat_Scheduling.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_Scheduling_h
+#define MINIXCompat_Scheduling_h
+
+#include <stdbool.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Host scheduling of emulator process trees.
+
+ `MINIXCOMPAT_CLASS` in the host environment selects a scheduling class for the whole tree of emulators started from one MINIXCompat invocation:
+
+ - `interactive` restores the host's default scheduling policy and priority if a lowered priority or batch policy was inherited from whatever started the emulator (as far as the host permits), and runs the emulated CPU in short slices so signals and queued writes are handled promptly.
+ - `batch` lowers the host priority, uses the host's batch scheduling policy where there is one, and runs the emulated CPU in longer slices, yielding the host CPU between them.
+
+ If `MINIXCOMPAT_CGROUP` names a host cgroup directory, the emulator also moves itself into that cgroup, warning if the host doesn't allow it.
+
+ All of this is applied once at startup. The host carries scheduling policy, priority, and cgroup membership across `fork(2)`, so every process in the tree shares them without any further work.
+ */
+
+
+/*! Initialize the scheduling subsystem, applying the scheduling class requested by the host environment. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Scheduling_Initialize(void);
+
+/*! The number of cycles the emulated CPU should run for at a time. */
+MINIXCOMPAT_EXTERN int MINIXCompat_Scheduling_SliceCycles(void);
+
+/*! Called at the end of each time slice, to give up the host CPU if appropriate for the scheduling class. */
+MINIXCOMPAT_EXTERN void MINIXCompat_Scheduling_EndSlice(void);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_Scheduling_h */
@@ -27,7 +27,9 @@
 #include "MINIXCompat_Filesystem.h"
 #include "MINIXCompat_Logging.h"
 #include "MINIXCompat_Messages.h"
+#include "MINIXCompat_Probes.h"
 #include "MINIXCompat_Processes.h"
+#include "MINIXCompat_WriteRing.h"
 
 
 #if DEBUG
@@ -310,6 +312,10 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
 
     minix_syscall_result_t result = minix_syscall_result_failure;
 
+    // Perform any writes queued asynchronously before this call, so they're ordered before it and before any fork(2), exec(2), or _exit(2).
+
+    MINIXCompat_WriteRing_Drain();
+
     // Get the message from emulator to host.
 
     minix_message_t *message = MINIXCompat_RAM_Copy_Block_To_Host(msg, sizeof(minix_message_t));
@@ -342,7 +348,9 @@ minix_syscall_result_t MINIXCompat_System_Call(minix_syscall_func_t func, uint16
 #endif
                     result = minix_syscall_result_failure;
                 } else {
+                    MINIXCOMPAT_PROBE2(syscall__entry, sc, msg);
                     result = scimpl(func, src_dest, msg, message, out_result);
+                    MINIXCOMPAT_PROBE2(syscall__return, sc, (int16_t) ntohs(message->m_type));
                 }
             } break;
 
@@ -441,12 +449,19 @@ minix_syscall_result_t MINIXCompat_SysCall_read(minix_syscall_func_t func, uint1
     int16_t minix_nbytes = message->m1_i2;
     m68k_address_t minix_buf = message->m1_p1;
 
-    uint8_t *buf = calloc(minix_nbytes, sizeof(uint8_t));
+    // Read directly into emulated RAM, rather than into a host buffer that then needs copying.
 
-    int16_t result = MINIXCompat_File_Read(minix_fd, buf, minix_nbytes);
+    int16_t result;
 
-    if (result > 0) {
-        MINIXCompat_RAM_Copy_Block_From_Host(minix_buf, buf, result);
+    if (minix_nbytes < 0) {
+        result = -minix_EINVAL;
+    } else if (minix_nbytes == 0) {
+        result = 0;
+    } else if ((minix_buf >= 0x01000000) || ((minix_buf + minix_nbytes) > 0x01000000)) {
+        result = -minix_EFAULT;
+    } else {
+        void *buf = MINIXCompat_RAM_Block_In_Host(minix_buf, minix_nbytes);
+        result = MINIXCompat_File_Read(minix_fd, buf, minix_nbytes);
     }
 
     // raed(2) replies with mess1
@@ -0,0 +1,231 @@
+//
+//  MINIXCompat_WorkingSet.c
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#include "MINIXCompat_WorkingSet.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_HostFile.h"
+#include "MINIXCompat_Logging.h"
+
+
+#if DEBUG
+
+/*! Uncomment to log recording and replay of working sets. */
+//#define DEBUG_WORKING_SET 1
+
+#endif
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+/*! The size of emulated RAM. */
+#define MINIXCompat_WorkingSet_RAMSize 0x01000000
+
+/*! The granularity of a working set, independent of the host's page size. */
+#define MINIXCompat_WorkingSet_PageSize 4096
+
+/*! The number of pages in a working set. */
+#define MINIXCompat_WorkingSet_PageCount (MINIXCompat_WorkingSet_RAMSize / MINIXCompat_WorkingSet_PageSize)
+
+/*! Working set file magic number and version. */
+static const uint32_t MINIXCompat_WorkingSet_Magic = 0x4D585753; // 'MXWS'
+static const uint32_t MINIXCompat_WorkingSet_Version = 1;
+
+
+/*!
+ A working set file, in host byte order since it's only meaningful on the host that recorded it.
+
+ - Note: This is laid out without any padding so it can be read and written directly.
+ */
+typedef struct minix_working_set {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t executable_size;
+    int64_t executable_mtime;
+    uint64_t executable_ino;
+
+    /*! One bit per page of emulated RAM, set if the page was touched. */
+    uint8_t pages[MINIXCompat_WorkingSet_PageCount / 8];
+} minix_working_set_t;
+
+
+/*! Whether working sets are in use at all. */
+static bool MINIXCompat_WorkingSet_Enabled = false;
+
+/*! The working set file to write when recording finishes, or `NULL` if not recording. */
+static char *MINIXCompat_WorkingSet_RecordingPath = NULL;
+
+/*! The host process doing the recording, since a child after `fork(2)` shouldn't also write the working set file. */
+static pid_t MINIXCompat_WorkingSet_RecordingPID = 0;
+
+/*! The working set being recorded, whose identity is filled in when recording starts. */
+static minix_working_set_t MINIXCompat_WorkingSet_Recording;
+
+
+void MINIXCompat_WorkingSet_Initialize(void)
+{
+    MINIXCompat_WorkingSet_Enabled = (getenv("MINIXCOMPAT_WORKING_SET") != NULL);
+}
+
+
+/*! Fault in the working set at \a ws_path if it matches \a host_stat, returning whether it did. */
+static bool MINIXCompat_WorkingSet_Replay(const char * _Nonnull ws_path, const struct stat * _Nonnull host_stat)
+{
+    minix_working_set_t working_set;
+
+    FILE *ws_file = fopen(ws_path, "r");
+    if (ws_file == NULL) return false;
+    size_t items_read = fread(&working_set, sizeof(minix_working_set_t), 1, ws_file);
+    fclose(ws_file);
+
+    if (   (items_read != 1)
+        || (working_set.magic != MINIXCompat_WorkingSet_Magic)
+        || (working_set.version != MINIXCompat_WorkingSet_Version)
+        || (working_set.executable_size != (uint64_t)host_stat->st_size)
+        || (working_set.executable_mtime != (int64_t)host_stat->st_mtime)
+        || (working_set.executable_ino != (uint64_t)host_stat->st_ino)) {
+        return false;
+    }
+
+    // Populate each run of touched pages.
+
+    size_t populated = 0;
+
+    size_t page = 0;
+    while (page < MINIXCompat_WorkingSet_PageCount) {
+        if ((working_set.pages[page / 8] & (1 << (page % 8))) == 0) {
+            page++;
+            continue;
+        }
+
+        size_t run_end = page + 1;
+        while ((run_end < MINIXCompat_WorkingSet_PageCount) && (working_set.pages[run_end / 8] & (1 << (run_end % 8)))) {
+            run_end++;
+        }
+
+        const uint32_t start = (uint32_t)(page * MINIXCompat_WorkingSet_PageSize);
+        const uint32_t length = (uint32_t)((run_end - page) * MINIXCompat_WorkingSet_PageSize);
+
+        MINIXCompat_RAM_Populate(start, length);
+        populated += length;
+
+        page = run_end;
+    }
+
+#if DEBUG_WORKING_SET
+    MINIXCompat_Log("working set %s: populated %zu bytes", ws_path, populated);
+#else
+    (void) populated;
+#endif
+
+    return true;
+}
+
+/*! Start recording the working set of an executable, with all of emulated RAM initially absent. */
+static void MINIXCompat_WorkingSet_StartRecording(char * _Nonnull ws_path, const struct stat * _Nonnull host_stat)
+{
+    // Discard emulated RAM, so only the pages this executable touches will be resident. Everything in RAM that matters is reestablished after the image is loaded.
+
+    if (!MINIXCompat_RAM_Discard()) {
+        // The old RAM is still in place, so just don't record.
+        free(ws_path);
+        return;
+    }
+
+    memset(&MINIXCompat_WorkingSet_Recording, 0, sizeof(minix_working_set_t));
+    MINIXCompat_WorkingSet_Recording.magic = MINIXCompat_WorkingSet_Magic;
+    MINIXCompat_WorkingSet_Recording.version = MINIXCompat_WorkingSet_Version;
+    MINIXCompat_WorkingSet_Recording.executable_size = host_stat->st_size;
+    MINIXCompat_WorkingSet_Recording.executable_mtime = host_stat->st_mtime;
+    MINIXCompat_WorkingSet_Recording.executable_ino = host_stat->st_ino;
+
+    MINIXCompat_WorkingSet_RecordingPath = ws_path;
+    MINIXCompat_WorkingSet_RecordingPID = getpid();
+}
+
+void MINIXCompat_WorkingSet_PrepareImage(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat)
+{
+    if (!MINIXCompat_WorkingSet_Enabled) return;
+
+    MINIXCompat_WorkingSet_Finish();
+
+    size_t ws_path_len = strlen(host_path) + sizeof(".ws");
+    char *ws_path = calloc(ws_path_len, sizeof(char));
+    snprintf(ws_path, ws_path_len, "%s.ws", host_path);
+
+    if (MINIXCompat_WorkingSet_Replay(ws_path, host_stat)) {
+        free(ws_path);
+    } else {
+        MINIXCompat_WorkingSet_StartRecording(ws_path, host_stat);
+    }
+}
+
+/*! Write a working set to a host file. */
+static bool MINIXCompat_WorkingSet_Write(FILE * _Nonnull ws_file, const void * _Nullable context)
+{
+    return (fwrite(context, sizeof(minix_working_set_t), 1, ws_file) == 1);
+}
+
+void MINIXCompat_WorkingSet_Finish(void)
+{
+    if (MINIXCompat_WorkingSet_RecordingPath == NULL) return;
+
+    char *ws_path = MINIXCompat_WorkingSet_RecordingPath;
+    MINIXCompat_WorkingSet_RecordingPath = NULL;
+
+    if (getpid() != MINIXCompat_WorkingSet_RecordingPID) {
+        free(ws_path);
+        return;
+    }
+
+    // Ask the host which pages of emulated RAM are resident, which since recording started means they were touched.
+
+    const size_t host_page_size = MINIXCompat_RAM_HostPageSize();
+    const size_t host_page_count = (MINIXCompat_WorkingSet_RAMSize + host_page_size - 1) / host_page_size;
+    uint8_t *residency = MINIXCompat_RAM_CopyResidency();
+
+    if (residency != NULL) {
+        minix_working_set_t *working_set = &MINIXCompat_WorkingSet_Recording;
+
+        for (size_t host_page = 0; host_page < host_page_count; host_page++) {
+            if (residency[host_page] == 0) continue;
+
+            const size_t first = (host_page * host_page_size) / MINIXCompat_WorkingSet_PageSize;
+            const size_t last = (((host_page + 1) * host_page_size) - 1) / MINIXCompat_WorkingSet_PageSize;
+            for (size_t page = first; (page <= last) && (page < MINIXCompat_WorkingSet_PageCount); page++) {
+                working_set->pages[page / 8] |= (1 << (page % 8));
+            }
+        }
+
+        bool saved = MINIXCompat_HostFile_WriteAtomically(ws_path, MINIXCompat_WorkingSet_Write, working_set);
+
+#if DEBUG_WORKING_SET
+        MINIXCompat_Log("working set %s: %s", ws_path, saved ? "saved" : "not saved");
+#else
+        (void) saved;
+#endif
+    }
+
+    free(residency);
+    free(ws_path);
+}
+
+
+MINIXCOMPAT_SOURCE_END
@@ -0,0 +1,49 @@
+//
+//  MINIXCompat_WorkingSet.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_WorkingSet_h
+#define MINIXCompat_WorkingSet_h
+
+#include <sys/stat.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ Recorded working sets of emulated memory.
+
+ When `MINIXCOMPAT_WORKING_SET` is set in the host environment, the first run of an executable records which 4KB pages of emulated memory it touched, in a file next to the executable with `.ws` appended. Later runs of the same executable fault in exactly those pages in one batch before the emulated CPU starts, rather than taking a host page fault for each one as it's first touched.
+
+ The working set file records the size, modification time, and inode of the executable it's for, and is ignored (and rerecorded) if they don't match. If the file can't be written, such as because the executable is in a read-only directory, the executable just runs without one.
+ */
+
+
+/*! Initialize the working set subsystem, enabling it if requested by the host environment. */
+MINIXCOMPAT_EXTERN void MINIXCompat_WorkingSet_Initialize(void);
+
+/*!
+ Prepare emulated memory for a new executable image, before it's copied in.
+
+ This finishes recording the working set of the previous executable (if any), and then either faults in the recorded working set of the new executable or starts recording it.
+
+ - Parameters:
+   - host_path: the host path of the executable
+   - host_stat: the host `stat(2)` of the executable, which identifies it
+ */
+MINIXCOMPAT_EXTERN void MINIXCompat_WorkingSet_PrepareImage(const char * _Nonnull host_path, const struct stat * _Nonnull host_stat);
+
+/*! Finish recording the working set of the current executable (if any), such as when exiting. */
+MINIXCOMPAT_EXTERN void MINIXCompat_WorkingSet_Finish(void);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_WorkingSet_h */
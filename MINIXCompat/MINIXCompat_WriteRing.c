@@ -0,0 +1,144 @@
+//
+//  MINIXCompat_WriteRing.c
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#include "MINIXCompat_WriteRing.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "MINIXCompat_Types.h"
+#include "MINIXCompat_Emulation.h"
+#include "MINIXCompat_Errors.h"
+#include "MINIXCompat_Filesystem.h"
+#include "MINIXCompat_Logging.h"
+
+
+#if DEBUG
+
+/*! Uncomment to log every write drained from the ring. */
+//#define DEBUG_WRITE_RING 1
+
+#endif
+
+
+MINIXCOMPAT_SOURCE_BEGIN
+
+
+const m68k_address_t MINIXCompat_WriteRing_Base = 0x00000400; // well above the reset vectors, well below the executable
+const uint32_t MINIXCompat_WriteRing_Magic = 0x4D585752; // 'MXWR'
+
+
+/*! Offsets of the ring's fields from ``MINIXCompat_WriteRing_Base``. */
+enum {
+    MINIXCompat_WriteRing_Offset_Magic = 0x00,
+    MINIXCompat_WriteRing_Offset_Count = 0x04,
+    MINIXCompat_WriteRing_Offset_Error = 0x06,
+    MINIXCompat_WriteRing_Offset_Head = 0x08,
+    MINIXCompat_WriteRing_Offset_Tail = 0x0C,
+    MINIXCompat_WriteRing_Offset_Entries = 0x10,
+};
+
+/*! Offsets of an entry's fields from the start of the entry. */
+enum {
+    MINIXCompat_WriteRing_Entry_Offset_FD = 0x00,
+    MINIXCompat_WriteRing_Entry_Offset_NBytes = 0x02,
+    MINIXCompat_WriteRing_Entry_Offset_Buf = 0x04,
+    MINIXCompat_WriteRing_Entry_Size = 0x08,
+};
+
+/*! The number of entries in the ring, which must fit (with the header) below ``MINIXCompat_Executable_Base``. */
+static const uint16_t MINIXCompat_WriteRing_Count = 64;
+
+
+/*! Whether the ring is in use at all. */
+static bool MINIXCompat_WriteRing_Enabled = false;
+
+
+void MINIXCompat_WriteRing_Initialize(void)
+{
+    MINIXCompat_WriteRing_Enabled = (getenv("MINIXCOMPAT_WRITE_RING") != NULL);
+}
+
+
+void MINIXCompat_WriteRing_Reset(void)
+{
+    if (!MINIXCompat_WriteRing_Enabled) return;
+
+    const m68k_address_t base = MINIXCompat_WriteRing_Base;
+
+    MINIXCompat_RAM_Write_32(base + MINIXCompat_WriteRing_Offset_Magic, MINIXCompat_WriteRing_Magic);
+    MINIXCompat_RAM_Write_16(base + MINIXCompat_WriteRing_Offset_Count, MINIXCompat_WriteRing_Count);
+    MINIXCompat_RAM_Write_16(base + MINIXCompat_WriteRing_Offset_Error, 0);
+    MINIXCompat_RAM_Write_32(base + MINIXCompat_WriteRing_Offset_Head, 0);
+    MINIXCompat_RAM_Write_32(base + MINIXCompat_WriteRing_Offset_Tail, 0);
+}
+
+
+/*! Perform a single queued write, returning the number of bytes written or `-errno`. */
+static int16_t MINIXCompat_WriteRing_PerformEntry(m68k_address_t entry_addr)
+{
+    minix_fd_t minix_fd = MINIXCompat_RAM_Read_16(entry_addr + MINIXCompat_WriteRing_Entry_Offset_FD);
+    int16_t minix_nbytes = MINIXCompat_RAM_Read_16(entry_addr + MINIXCompat_WriteRing_Entry_Offset_NBytes);
+    m68k_address_t minix_buf = MINIXCompat_RAM_Read_32(entry_addr + MINIXCompat_WriteRing_Entry_Offset_Buf);
+
+    // Unlike a synchronous write(2), nothing is waiting on this one, so validate it rather than trusting the guest.
+
+    if (!MINIXCompat_File_IsWritable(minix_fd)) return -minix_EBADF;
+    if (minix_nbytes < 0) return -minix_EINVAL;
+    if (minix_nbytes == 0) return 0;
+    if ((minix_buf >= 0x01000000) || ((minix_buf + minix_nbytes) > 0x01000000)) return -minix_EFAULT;
+
+    uint8_t *buf = MINIXCompat_RAM_Copy_Block_To_Host(minix_buf, minix_nbytes);
+    int16_t result = MINIXCompat_File_Write(minix_fd, buf, minix_nbytes);
+    free(buf);
+
+#if DEBUG_WRITE_RING
+    MINIXCompat_Log("ring write(%d, 0x%08x, %d) -> %d", minix_fd, minix_buf, minix_nbytes, result);
+#endif
+
+    return result;
+}
+
+
+void MINIXCompat_WriteRing_Drain(void)
+{
+    if (!MINIXCompat_WriteRing_Enabled) return;
+
+    const m68k_address_t base = MINIXCompat_WriteRing_Base;
+
+    uint32_t head = MINIXCompat_RAM_Read_32(base + MINIXCompat_WriteRing_Offset_Head);
+    uint32_t tail = MINIXCompat_RAM_Read_32(base + MINIXCompat_WriteRing_Offset_Tail);
+    if (head == tail) return;
+
+    // A guest that has submitted more than a ring's worth has corrupted it; drop what can't be trusted rather than replaying stale entries.
+
+    if ((head - tail) > MINIXCompat_WriteRing_Count) {
+        tail = head - MINIXCompat_WriteRing_Count;
+    }
+
+    int16_t error = (int16_t) MINIXCompat_RAM_Read_16(base + MINIXCompat_WriteRing_Offset_Error);
+
+    for (; tail != head; tail++) {
+        m68k_address_t entry_addr = (base + MINIXCompat_WriteRing_Offset_Entries
+                                     + ((tail % MINIXCompat_WriteRing_Count) * MINIXCompat_WriteRing_Entry_Size));
+        int16_t result = MINIXCompat_WriteRing_PerformEntry(entry_addr);
+
+        // Only the first error is kept, until the guest clears it.
+
+        if ((result < 0) && (error == 0)) {
+            error = result;
+        }
+    }
+
+    MINIXCompat_RAM_Write_16(base + MINIXCompat_WriteRing_Offset_Error, error);
+    MINIXCompat_RAM_Write_32(base + MINIXCompat_WriteRing_Offset_Tail, tail);
+}
+
+
+MINIXCOMPAT_SOURCE_END
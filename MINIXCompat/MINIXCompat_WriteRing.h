@@ -0,0 +1,56 @@
+//
+//  MINIXCompat_WriteRing.h
+//  MINIXCompat
+//
+//  Copyright © 2024 Christopher M. Hanson. See file LICENSE for details.
+//
+
+#ifndef MINIXCompat_WriteRing_h
+#define MINIXCompat_WriteRing_h
+
+#include <stdint.h>
+
+#include "MINIXCompat_Types.h"
+
+
+MINIXCOMPAT_HEADER_BEGIN
+
+
+/*!
+ The asynchronous write submission ring.
+
+ A patched MINIX libc can queue `write(2)` requests here instead of trapping into the emulator for each one. The ring lives at a fixed address below ``MINIXCompat_Executable_Base`` and is only present when `MINIXCOMPAT_WRITE_RING` is set in the host environment; a guest should check for ``MINIXCompat_WriteRing_Magic`` at ``MINIXCompat_WriteRing_Base`` before using it.
+
+ Everything in the ring is in Motorola (network) byte order:
+
+     +0x00: magic (uint32_t, written by the emulator)
+     +0x04: number of entries (uint16_t, written by the emulator)
+     +0x06: error (int16_t, `-errno` of the first failed queued write, cleared by the guest)
+     +0x08: head (uint32_t, count of entries submitted, written by the guest)
+     +0x0C: tail (uint32_t, count of entries completed, written by the emulator)
+     +0x10: entries, each an fd (int16_t), byte count (int16_t), and buffer address (uint32_t)
+
+ The guest fills in entry `head % count` and then increments `head`; it must not touch the buffer an entry refers to until `tail` has moved past that entry. The emulator drains the ring in order at the end of each time slice and before every other system call, so queued writes are never reordered with respect to synchronous ones, and a failure is visible in `error` by the time the next synchronous system call returns.
+ */
+
+/*! Address in emulated RAM of the write submission ring. */
+MINIXCOMPAT_EXTERN const m68k_address_t MINIXCompat_WriteRing_Base;
+
+/*! Value at ``MINIXCompat_WriteRing_Base`` when the write submission ring is available. */
+MINIXCOMPAT_EXTERN const uint32_t MINIXCompat_WriteRing_Magic;
+
+
+/*! Initialize the write ring subsystem, enabling it if requested by the host environment. */
+MINIXCOMPAT_EXTERN void MINIXCompat_WriteRing_Initialize(void);
+
+/*! Establish an empty ring in emulated RAM, which must be done each time a new executable is started. */
+MINIXCOMPAT_EXTERN void MINIXCompat_WriteRing_Reset(void);
+
+/*! Perform, in order, all of the writes that have been submitted to the ring. */
+MINIXCOMPAT_EXTERN void MINIXCompat_WriteRing_Drain(void);
+
+
+MINIXCOMPAT_HEADER_END
+
+
+#endif /* MINIXCompat_WriteRing_h */